@@ -2,6 +2,9 @@
 
 #include "FPCharacter.h"
 #include "FirstPersonFootstepData.h"
+#include "FirstPersonInteractableComponent.h"
+#include "FirstPersonInteractionSubsystem.h"
+#include "FirstPersonLagCompensationSubsystem.h"
 
 #include "Components/InputComponent.h"
 #include "Components/CapsuleComponent.h"
@@ -15,6 +18,11 @@
 
 #include "Kismet/GameplayStatics.h"
 
+#include "Misc/Guid.h"
+#include "Misc/Paths.h"
+
+#include "PhysicalMaterials/PhysicalMaterial.h"
+
 #include "Sound/SoundBase.h"
 
 #include "GameplayCameras/Public/MatineeCameraShake.h"
@@ -64,6 +72,9 @@ void AFPCharacter::BeginPlay()
 
 	// Initialization
 	OriginalCameraLocation = CameraComponent->GetRelativeLocation();
+	SimulatedCameraLocation = OriginalCameraLocation;
+	PreviousCameraLocation = OriginalCameraLocation;
+	SimulationAccumulator = 0.0f;
 	OriginalCapsuleHalfHeight = GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
 	bCanUnCrouch = true;
 
@@ -74,15 +85,78 @@ void AFPCharacter::BeginPlay()
 
 	// Input setup
 	SetupInputBindings();
+
+	// Telemetry setup
+	StartTelemetry();
+
+	// Lag compensation setup, only a networked server needs to rewind capsules
+	if (LagCompensation.bRecordCapsuleHistory && HasAuthority() && (IsNetMode(NM_DedicatedServer) || IsNetMode(NM_ListenServer)))
+	{
+		CapsuleHistory.Init(LagCompensation.HistorySize);
+
+		if (UFirstPersonLagCompensationSubsystem* LagCompensationSubsystem = GetWorld()->GetSubsystem<UFirstPersonLagCompensationSubsystem>())
+			LagCompensationSubsystem->Register(this);
+	}
+}
+
+void AFPCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// The writer thread flushes any pending events and closes the log
+	if (TelemetryStream)
+	{
+		FFirstPersonTelemetryWriter::Unregister(TelemetryStream.ToSharedRef());
+		TelemetryStream.Reset();
+	}
+
+	SetFocusedInteractable(nullptr);
+
+	if (CapsuleHistory.IsInitialized())
+	{
+		if (UFirstPersonLagCompensationSubsystem* LagCompensationSubsystem = GetWorld()->GetSubsystem<UFirstPersonLagCompensationSubsystem>())
+			LagCompensationSubsystem->Unregister(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void AFPCharacter::Tick(const float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 
-	UpdateCameraShake();
+	if (Simulation.bUseFixedTimestep)
+	{
+		const float FixedDeltaTime = 1.0f / Simulation.FixedTimestepRate;
+		SimulationAccumulator += DeltaTime;
 
-	UpdateCrouch(DeltaTime);
+		int32 Steps = 0;
+		while (SimulationAccumulator >= FixedDeltaTime && Steps < Simulation.MaxStepsPerFrame)
+		{
+			PreviousCameraLocation = SimulatedCameraLocation;
+			StepLocomotion(FixedDeltaTime);
+
+			SimulationAccumulator -= FixedDeltaTime;
+			Steps++;
+		}
+
+		// Drop whatever we could not catch up on
+		if (SimulationAccumulator >= FixedDeltaTime)
+			SimulationAccumulator = FMath::Fmod(SimulationAccumulator, FixedDeltaTime);
+
+		// Present the camera between the last two steps
+		CameraComponent->SetRelativeLocation(FMath::Lerp(PreviousCameraLocation, SimulatedCameraLocation, SimulationAccumulator / FixedDeltaTime));
+	}
+	else
+	{
+		StepLocomotion(DeltaTime);
+
+		CameraComponent->SetRelativeLocation(SimulatedCameraLocation);
+	}
+
+	if (CapsuleHistory.IsInitialized())
+		RecordCapsuleSample();
+
+	if (Interaction.bEnableInteraction && IsLocallyControlled())
+		UpdateInteractionFocus();
 }
 
 void AFPCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
@@ -119,6 +193,8 @@ void AFPCharacter::Jump()
 
 void AFPCharacter::Landed(const FHitResult& Hit)
 {
+	RecordTelemetryEvent(EFirstPersonTelemetryEventType::Landed, Hit.ImpactPoint, 0, -GetVelocity().Z);
+
 	if (!bIsCrouching)
 	{
 		Super::Landed(Hit);
@@ -136,15 +212,42 @@ void AFPCharacter::PossessedBy(AController* NewController)
 	Super::PossessedBy(NewController);
 
 	PlayerController = Cast<APlayerController>(NewController);
+
+	StartTelemetry();
+}
+
+void AFPCharacter::PawnClientRestart()
+{
+	Super::PawnClientRestart();
+
+	// Owning clients only become locally controlled once possession has replicated
+	StartTelemetry();
+}
+
+void AFPCharacter::StartTelemetry()
+{
+	// Simulated proxies would only duplicate what the owning client and the server already record
+	if (!Telemetry.bEnableTelemetry || TelemetryStream || !(HasAuthority() || IsLocallyControlled()))
+		return;
+
+	// Every PIE instance and every net mode shares Saved/, so the name has to be unique per process and per world
+	const TCHAR* NetMode = IsNetMode(NM_DedicatedServer) ? TEXT("Server") : IsNetMode(NM_ListenServer) ? TEXT("ListenServer") : IsNetMode(NM_Client) ? TEXT("Client") : TEXT("Standalone");
+	const FString Filename = FPaths::ProjectSavedDir() / TEXT("Telemetry") / FString::Printf(TEXT("%s_%s_%s_%s.fptl"), *GetName(), NetMode, *FDateTime::Now().ToString(), *FGuid::NewGuid().ToString(EGuidFormats::Digits));
+
+	const FFirstPersonTelemetryStreamRef Stream = MakeShared<FFirstPersonTelemetryStream, ESPMode::ThreadSafe>(Telemetry.BufferCapacity);
+	if (Stream->Open(Filename) && FFirstPersonTelemetryWriter::Register(Stream))
+		TelemetryStream = Stream;
 }
 
 void AFPCharacter::StartCrouch()
 {
 	if (GetCharacterMovement()->IsMovingOnGround() && bCanUnCrouch)
 	{
-		bIsCrouching = !bIsCrouching;
+		const bool bNewCrouching = !bIsCrouching;
 		
-		GetCharacterMovement()->MaxWalkSpeed = bIsCrouching ? Movement.CrouchSpeed : Movement.WalkSpeed;
+		GetCharacterMovement()->MaxWalkSpeed = bNewCrouching ? Movement.CrouchSpeed : Movement.WalkSpeed;
+
+		SetCrouching(bNewCrouching);
 	}
 }
 
@@ -154,11 +257,32 @@ void AFPCharacter::StopCrouching()
 	if (!Movement.bToggleToCrouch && bCanUnCrouch)
 	{
 		GetCharacterMovement()->MaxWalkSpeed = Movement.WalkSpeed;
-		
-		bIsCrouching = false;
+
+		SetCrouching(false);
 	}
 }
 
+void AFPCharacter::SetCrouching(const bool bNewCrouching)
+{
+	if (bIsCrouching == bNewCrouching)
+		return;
+
+	bIsCrouching = bNewCrouching;
+
+	RecordTelemetryEvent(EFirstPersonTelemetryEventType::StanceChanged, GetActorLocation());
+
+	// Crouching is driven by local input, the server needs it to resize the authoritative capsule
+	if (!HasAuthority())
+		ServerSetCrouching(bNewCrouching);
+}
+
+void AFPCharacter::ServerSetCrouching_Implementation(const bool bNewCrouching)
+{
+	GetCharacterMovement()->MaxWalkSpeed = bNewCrouching ? Movement.CrouchSpeed : Movement.WalkSpeed;
+
+	SetCrouching(bNewCrouching);
+}
+
 void AFPCharacter::MoveForward(const float AxisValue)
 {
 	if (Controller)
@@ -174,29 +298,6 @@ void AFPCharacter::MoveForward(const float AxisValue)
 
 		// Apply movement in the calculated direction
 		AddMovementInput(Direction, AxisValue);
-
-		if (FootstepSettings.bEnableFootsteps)
-		{
-			// Continously add to Travel Distance when moving
-			if (GetCharacterMovement()->Velocity.Size() > 0.0f && GetCharacterMovement()->IsMovingOnGround())
-			{
-				TravelDistance += (GetActorLocation() - LastLocation).Size();
-				LastLocation = GetActorLocation();
-			}
-			// Reset when not moving AND if we are falling
-			else if (GetCharacterMovement()->IsFalling())
-			{
-				LastLocation = GetActorLocation();
-				TravelDistance = 0.0f;
-			}
-
-			// Is it time to play a footstep sound?
-			if (GetCharacterMovement()->IsMovingOnGround() && TravelDistance > FootstepSettings.CurrentStride)
-			{
-				PlayFootstepSound();
-				TravelDistance = 0;
-			}
-		}
 	}
 }
 
@@ -220,6 +321,8 @@ void AFPCharacter::Run()
 		GetCharacterMovement()->MaxWalkSpeed = Movement.RunSpeed;
 
 		bIsRunning = true;
+
+		RecordTelemetryEvent(EFirstPersonTelemetryEventType::GaitChanged, GetActorLocation());
 	}
 }
 
@@ -230,18 +333,58 @@ void AFPCharacter::StopRunning()
 		GetCharacterMovement()->MaxWalkSpeed = Movement.WalkSpeed;
 
 		bIsRunning = false;
+
+		RecordTelemetryEvent(EFirstPersonTelemetryEventType::GaitChanged, GetActorLocation());
+	}
+}
+
+void AFPCharacter::StepLocomotion(const float DeltaTime)
+{
+	UpdateFootsteps();
+
+	UpdateCameraShake();
+
+	UpdateCrouch(DeltaTime);
+}
+
+void AFPCharacter::UpdateFootsteps()
+{
+	// Footsteps are only played for the player controlling this character
+	if (IsLocallyControlled() && FootstepSettings.bEnableFootsteps)
+	{
+		// Continously add to Travel Distance when moving
+		if (GetCharacterMovement()->Velocity.Size() > 0.0f && GetCharacterMovement()->IsMovingOnGround())
+		{
+			TravelDistance += (GetActorLocation() - LastLocation).Size();
+			LastLocation = GetActorLocation();
+		}
+		// Reset when not moving AND if we are falling
+		else if (GetCharacterMovement()->IsFalling())
+		{
+			LastLocation = GetActorLocation();
+			TravelDistance = 0.0f;
+		}
+
+		// Is it time to play a footstep sound?
+		if (GetCharacterMovement()->IsMovingOnGround() && TravelDistance > FootstepSettings.CurrentStride)
+		{
+			PlayFootstepSound();
+			TravelDistance = 0;
+		}
 	}
 }
 
 void AFPCharacter::UpdateCrouch(const float DeltaTime)
 {
+	// Clamped so a long frame or step lands on the target instead of overshooting it
+	const float Alpha = FMath::Min(Movement.StandToCrouchTransitionSpeed * DeltaTime, 1.0f);
+
 	if (bIsCrouching)
 	{
 		// Smoothly move camera to target location and smoothly decrease the capsule height to fit through small openings
-		const FVector NewLocation = FMath::Lerp(CameraComponent->GetRelativeLocation(), FVector(0.0f, 0.0f, 30.0f), Movement.StandToCrouchTransitionSpeed * DeltaTime);
-		const float NewHalfHeight = FMath::Lerp(GetCapsuleComponent()->GetUnscaledCapsuleHalfHeight(), OriginalCapsuleHalfHeight/2.0f, Movement.StandToCrouchTransitionSpeed * DeltaTime);
+		SimulatedCameraLocation = FMath::Lerp(SimulatedCameraLocation, FVector(0.0f, 0.0f, 30.0f), Alpha);
+		const float NewHalfHeight = FMath::Lerp(GetCapsuleComponent()->GetUnscaledCapsuleHalfHeight(), OriginalCapsuleHalfHeight/2.0f, Alpha);
 		
-		CameraComponent->SetRelativeLocation(NewLocation);
 		GetCapsuleComponent()->SetCapsuleHalfHeight(NewHalfHeight);
 
 		if (IsBlockedInCrouchStance())
@@ -252,10 +395,9 @@ void AFPCharacter::UpdateCrouch(const float DeltaTime)
 	else
 	{
 		// Smoothly move camera back to original location and smoothly increase the capsule height to the original height
-		const FVector NewLocation = FMath::Lerp(CameraComponent->GetRelativeLocation(), OriginalCameraLocation, Movement.StandToCrouchTransitionSpeed * DeltaTime);
-		const float NewHalfHeight = FMath::Lerp(GetCapsuleComponent()->GetUnscaledCapsuleHalfHeight(), OriginalCapsuleHalfHeight, Movement.StandToCrouchTransitionSpeed * DeltaTime);
+		SimulatedCameraLocation = FMath::Lerp(SimulatedCameraLocation, OriginalCameraLocation, Alpha);
+		const float NewHalfHeight = FMath::Lerp(GetCapsuleComponent()->GetUnscaledCapsuleHalfHeight(), OriginalCapsuleHalfHeight, Alpha);
 
-		CameraComponent->SetRelativeLocation(NewLocation);
 		GetCapsuleComponent()->SetCapsuleHalfHeight(NewHalfHeight);
 	}
 }
@@ -269,6 +411,21 @@ bool AFPCharacter::IsBlockedInCrouchStance()
 	return GetWorld()->LineTraceSingleByChannel(HitResult, GetActorLocation(), GetActorLocation() + RayLength, ECC_Visibility);
 }
 
+void AFPCharacter::RecordCapsuleSample()
+{
+	// Sampled after UpdateCrouch so the history reflects this frame's capsule height
+	const UCapsuleComponent* Capsule = GetCapsuleComponent();
+
+	FFirstPersonCapsuleSample Sample;
+	Sample.Timestamp = GetWorld()->GetTimeSeconds();
+	Sample.Location = Capsule->GetComponentLocation();
+	Sample.Rotation = Capsule->GetComponentQuat();
+	Sample.HalfHeight = Capsule->GetScaledCapsuleHalfHeight();
+	Sample.Stance = bIsCrouching ? EFirstPersonStance::Crouching : EFirstPersonStance::Standing;
+
+	CapsuleHistory.Record(Sample);
+}
+
 void AFPCharacter::UpdateCameraShake()
 {	
 	if (PlayerController)
@@ -286,6 +443,15 @@ void AFPCharacter::UpdateCameraShake()
 	}
 }
 
+float AFPCharacter::GetLookInputDeltaTime() const
+{
+	// A constant scale keeps the same mouse movement turning the same amount at any frame rate.
+	// Deliberately not tied to the step rate, so tuning the simulation never changes sensitivity
+	static constexpr float ReferenceLookDeltaTime = 1.0f / 60.0f;
+
+	return Simulation.bUseFixedTimestep ? ReferenceLookDeltaTime : GetWorld()->GetDeltaSeconds();
+}
+
 void AFPCharacter::Quit()
 {
 	UKismetSystemLibrary::QuitGame(GetWorld(), Cast<APlayerController>(GetController()), EQuitPreference::Quit, true);
@@ -293,7 +459,102 @@ void AFPCharacter::Quit()
 
 void AFPCharacter::Interact()
 {
-	UE_LOG(LogTemp, Warning, TEXT("No functionality, derive from this character and implement this event"))
+	UFirstPersonInteractableComponent* Interactable = FocusedInteractable.Get();
+	if (!Interactable)
+		return;
+
+	// Focus is found locally, but the interaction itself has to happen on the server to affect the game
+	if (HasAuthority())
+		Interactable->Interact(this);
+	else
+		ServerInteract(Interactable);
+}
+
+void AFPCharacter::ServerInteract_Implementation(UFirstPersonInteractableComponent* Interactable)
+{
+	if (!Interactable || !Interactable->IsInteractionEnabled())
+		return;
+
+	// Re-check range and view cone with some slack, the client saw this a round trip ago
+	const float Tolerance = 1.2f;
+	const FVector ViewLocation = CameraComponent->GetComponentLocation();
+	const FVector ToInteractable = Interactable->GetComponentLocation() - ViewLocation;
+	const float MaxDistance = Interaction.InteractionDistance * Tolerance;
+	if (ToInteractable.SizeSquared() > FMath::Square(MaxDistance))
+		return;
+
+	const float MaxAngle = FMath::Min(Interaction.FocusAngle * Tolerance + 10.0f, 180.0f);
+	const float Dot = FVector::DotProduct(ToInteractable.GetSafeNormal(), GetBaseAimRotation().Vector());
+	if (Dot < FMath::Cos(FMath::DegreesToRadians(MaxAngle)))
+		return;
+
+	Interactable->Interact(this);
+}
+
+void AFPCharacter::UpdateInteractionFocus()
+{
+	UFirstPersonInteractionSubsystem* InteractionSubsystem = GetWorld()->GetSubsystem<UFirstPersonInteractionSubsystem>();
+	if (!InteractionSubsystem)
+		return;
+
+	const FVector ViewLocation = CameraComponent->GetComponentLocation();
+	UFirstPersonInteractableComponent* Candidate = InteractionSubsystem->FindFocusCandidate(ViewLocation, CameraComponent->GetForwardVector(), Interaction.InteractionDistance, Interaction.FocusAngle, this);
+
+	// Trace straight away when we are looking at something new, otherwise only re-check visibility every so often
+	const float CurrentTime = GetWorld()->GetTimeSeconds();
+	const bool bCandidateChanged = Candidate != FocusCandidate.Get();
+	const bool bRecheckDue = Candidate && CurrentTime - LastFocusTraceTime >= Interaction.FocusRecheckInterval;
+	if (!bCandidateChanged && !bRecheckDue && !FocusedInteractable.IsStale())
+		return;
+
+	FocusCandidate = Candidate;
+
+	if (Candidate)
+	{
+		LastFocusTraceTime = CurrentTime;
+
+		FHitResult HitResult;
+		FCollisionQueryParams QueryParams(FName("InteractionFocus"), false, this);
+
+		const bool bBlocked = GetWorld()->LineTraceSingleByChannel(HitResult, ViewLocation, Candidate->GetComponentLocation(), ECC_Visibility, QueryParams) && HitResult.GetActor() != Candidate->GetOwner();
+		if (bBlocked)
+			Candidate = nullptr;
+	}
+
+	SetFocusedInteractable(Candidate);
+}
+
+void AFPCharacter::ReleaseFocus(UFirstPersonInteractableComponent* Interactable)
+{
+	if (FocusCandidate.Get(true) == Interactable)
+		FocusCandidate = nullptr;
+
+	if (FocusedInteractable.Get(true) == Interactable)
+		SetFocusedInteractable(nullptr);
+}
+
+void AFPCharacter::SetFocusedInteractable(UFirstPersonInteractableComponent* NewFocus)
+{
+	// Still resolves an interactable that is being destroyed, so it gets its end of focus events
+	UFirstPersonInteractableComponent* OldFocus = FocusedInteractable.Get(true);
+	if (NewFocus == OldFocus && !FocusedInteractable.IsStale())
+		return;
+
+	FocusedInteractable = NewFocus;
+
+	if (OldFocus)
+	{
+		OldFocus->FocusingCharacters.RemoveSwap(this);
+		OldFocus->OnFocusEnd.Broadcast(this);
+	}
+
+	if (NewFocus)
+	{
+		NewFocus->FocusingCharacters.AddUnique(this);
+		NewFocus->OnFocusBegin.Broadcast(this);
+	}
+
+	OnFocusChanged.Broadcast(NewFocus, OldFocus);
 }
 
 void AFPCharacter::PlayFootstepSound()
@@ -318,6 +579,10 @@ void AFPCharacter::PlayFootstepSound()
 	}
 
 	LastFootstepLocation = FloorResult.HitResult.Location;
+
+	const UPhysicalMaterial* Surface = FloorResult.HitResult.PhysMaterial.Get();
+	const uint8 SurfaceType = Surface ? static_cast<uint8>(Surface->SurfaceType.GetValue()) : static_cast<uint8>(SurfaceType_Default);
+	RecordTelemetryEvent(EFirstPersonTelemetryEventType::Footstep, LastFootstepLocation, SurfaceType, FootstepSettings.CurrentStride);
 }
 
 USoundBase* AFPCharacter::GetFootstepSound(TWeakObjectPtr<UPhysicalMaterial>* Surface)
@@ -336,6 +601,23 @@ USoundBase* AFPCharacter::GetFootstepSound(TWeakObjectPtr<UPhysicalMaterial>* Su
 	return nullptr;
 }
 
+void AFPCharacter::RecordTelemetryEvent(const EFirstPersonTelemetryEventType Type, const FVector& Location, const uint8 Surface, const float Value) const
+{
+	if (TelemetryStream)
+	{
+		FFirstPersonTelemetryEvent Event;
+		Event.Timestamp = GetWorld()->GetTimeSeconds();
+		Event.Type = Type;
+		Event.Surface = Surface;
+		Event.Stance = bIsCrouching ? EFirstPersonStance::Crouching : EFirstPersonStance::Standing;
+		Event.Gait = bIsRunning ? EFirstPersonGait::Running : EFirstPersonGait::Walking;
+		Event.Location = Location;
+		Event.Value = Value;
+
+		TelemetryStream->Record(Event);
+	}
+}
+
 void AFPCharacter::SetupInputBindings()
 {
 	ActionMappings = Input->GetActionMappings();
@@ -433,10 +715,10 @@ void AFPCharacter::ResetToDefaultInputBindings()
 
 void AFPCharacter::AddControllerYawInput(const float Value)
 {
-	return Super::AddControllerYawInput(Value * Camera.SensitivityX * GetWorld()->GetDeltaSeconds());
+	return Super::AddControllerYawInput(Value * Camera.SensitivityX * GetLookInputDeltaTime());
 }
 
 void AFPCharacter::AddControllerPitchInput(const float Value)
 {
-	Super::AddControllerPitchInput(Value * Camera.SensitivityY * GetWorld()->GetDeltaSeconds());
+	Super::AddControllerPitchInput(Value * Camera.SensitivityY * GetLookInputDeltaTime());
 }
@@ -0,0 +1,77 @@
+// Copyright Ali El Saleh, 2020
+
+#include "FirstPersonCapsuleHistory.h"
+
+void FFirstPersonCapsuleHistory::Init(const int32 Capacity)
+{
+	const int32 RoundedCapacity = static_cast<int32>(FMath::RoundUpToPowerOfTwo(FMath::Max(Capacity, 2)));
+
+	Samples.Reset();
+	Samples.SetNumZeroed(RoundedCapacity);
+	Mask = RoundedCapacity - 1;
+
+	Reset();
+}
+
+void FFirstPersonCapsuleHistory::Reset()
+{
+	Head = 0;
+	Count = 0;
+}
+
+void FFirstPersonCapsuleHistory::Record(const FFirstPersonCapsuleSample& Sample)
+{
+	check(IsInitialized());
+
+	// Multiple samples in the same frame, keep the latest one
+	if (Count > 0 && Sample.Timestamp <= GetNewestTimestamp())
+	{
+		Samples[(Head - 1) & Mask] = Sample;
+		return;
+	}
+
+	Samples[Head] = Sample;
+	Head = (Head + 1) & Mask;
+	Count = FMath::Min(Count + 1, Samples.Num());
+}
+
+bool FFirstPersonCapsuleHistory::Rewind(const float Timestamp, FFirstPersonCapsuleSample& OutSample) const
+{
+	if (Count == 0)
+		return false;
+
+	if (Timestamp <= GetOldestTimestamp())
+	{
+		OutSample = GetSample(0);
+		return Timestamp == OutSample.Timestamp;
+	}
+
+	if (Timestamp >= GetNewestTimestamp())
+	{
+		OutSample = GetSample(Count - 1);
+		return true;
+	}
+
+	// Binary search for the first sample newer than Timestamp
+	int32 Low = 1;
+	int32 High = Count - 1;
+	while (Low < High)
+	{
+		const int32 Middle = (Low + High) / 2;
+		if (GetSample(Middle).Timestamp > Timestamp)
+			High = Middle;
+		else
+			Low = Middle + 1;
+	}
+
+	const FFirstPersonCapsuleSample& Before = GetSample(Low - 1);
+	const FFirstPersonCapsuleSample& After = GetSample(Low);
+	const float Alpha = (Timestamp - Before.Timestamp) / (After.Timestamp - Before.Timestamp);
+
+	OutSample.Timestamp = Timestamp;
+	OutSample.Location = FMath::Lerp(Before.Location, After.Location, Alpha);
+	OutSample.Rotation = FQuat::Slerp(Before.Rotation, After.Rotation, Alpha);
+	OutSample.HalfHeight = FMath::Lerp(Before.HalfHeight, After.HalfHeight, Alpha);
+	OutSample.Stance = Alpha < 0.5f ? Before.Stance : After.Stance;
+	return true;
+}
@@ -1,6 +1,7 @@
 // Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
 
 #include "FirstPersonCharacter.h"
+#include "FirstPersonTelemetry.h"
 
 #define LOCTEXT_NAMESPACE "FFirstPersonCharacterModule"
 
@@ -13,6 +14,9 @@ void FFirstPersonCharacterModule::ShutdownModule()
 {
 	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
 	// we call this function before unloading the module.
+
+	// Flush any telemetry still being recorded and stop the writer thread
+	FFirstPersonTelemetryWriter::Shutdown();
 }
 
 #undef LOCTEXT_NAMESPACE
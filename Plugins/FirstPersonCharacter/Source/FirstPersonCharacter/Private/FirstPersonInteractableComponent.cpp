@@ -0,0 +1,51 @@
+// Copyright Ali El Saleh, 2020
+
+#include "FirstPersonInteractableComponent.h"
+#include "FirstPersonInteractionSubsystem.h"
+#include "FPCharacter.h"
+
+#include "Engine/World.h"
+
+void UFirstPersonInteractableComponent::Interact(AFPCharacter* Character)
+{
+	if (bInteractionEnabled)
+		OnInteract.Broadcast(Character);
+}
+
+void UFirstPersonInteractableComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (UFirstPersonInteractionSubsystem* InteractionSubsystem = GetWorld()->GetSubsystem<UFirstPersonInteractionSubsystem>())
+		InteractionSubsystem->Add(this);
+}
+
+void UFirstPersonInteractableComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UFirstPersonInteractionSubsystem* InteractionSubsystem = GetWorld()->GetSubsystem<UFirstPersonInteractionSubsystem>())
+		InteractionSubsystem->Remove(this);
+
+	// Releasing focus removes the character from FocusingCharacters, so iterate over a copy
+	const TArray<TWeakObjectPtr<AFPCharacter>> Characters = FocusingCharacters;
+	for (const TWeakObjectPtr<AFPCharacter>& Character : Characters)
+	{
+		if (Character.IsValid())
+			Character->ReleaseFocus(this);
+	}
+
+	FocusingCharacters.Reset();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UFirstPersonInteractableComponent::OnUpdateTransform(const EUpdateTransformFlags UpdateTransformFlags, const ETeleportType Teleport)
+{
+	Super::OnUpdateTransform(UpdateTransformFlags, Teleport);
+
+	// Keep moving interactables in the right cell
+	if (bIsInGrid)
+	{
+		if (UFirstPersonInteractionSubsystem* InteractionSubsystem = GetWorld()->GetSubsystem<UFirstPersonInteractionSubsystem>())
+			InteractionSubsystem->Update(this);
+	}
+}
@@ -0,0 +1,114 @@
+// Copyright Ali El Saleh, 2020
+
+#include "FirstPersonInteractionSubsystem.h"
+#include "FirstPersonInteractableComponent.h"
+
+void UFirstPersonInteractionSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	CellSize = FMath::Max(CellSize, 1.0f);
+}
+
+void UFirstPersonInteractionSubsystem::Add(UFirstPersonInteractableComponent* Interactable)
+{
+	if (Interactable->bIsInGrid)
+		return;
+
+	Interactable->GridCell = GetCell(Interactable->GetComponentLocation());
+	Interactable->bIsInGrid = true;
+
+	Cells.FindOrAdd(Interactable->GridCell).Add(Interactable);
+}
+
+void UFirstPersonInteractionSubsystem::Remove(UFirstPersonInteractableComponent* Interactable)
+{
+	if (!Interactable->bIsInGrid)
+		return;
+
+	if (TArray<UFirstPersonInteractableComponent*>* Cell = Cells.Find(Interactable->GridCell))
+	{
+		Cell->RemoveSwap(Interactable);
+
+		if (Cell->Num() == 0)
+			Cells.Remove(Interactable->GridCell);
+	}
+
+	Interactable->bIsInGrid = false;
+}
+
+void UFirstPersonInteractionSubsystem::Update(UFirstPersonInteractableComponent* Interactable)
+{
+	// Most transform updates stay within the same cell
+	if (Interactable->bIsInGrid && GetCell(Interactable->GetComponentLocation()) != Interactable->GridCell)
+	{
+		Remove(Interactable);
+		Add(Interactable);
+	}
+}
+
+UFirstPersonInteractableComponent* UFirstPersonInteractionSubsystem::FindFocusCandidate(const FVector& ViewLocation, const FVector& ViewDirection, const float MaxDistance, const float HalfAngle, const AActor* IgnoreActor) const
+{
+	const FIntVector MinCell = GetCell(ViewLocation - FVector(MaxDistance));
+	const FIntVector MaxCell = GetCell(ViewLocation + FVector(MaxDistance));
+	const float MaxDistanceSquared = FMath::Square(MaxDistance);
+	const float MinDot = FMath::Cos(FMath::DegreesToRadians(HalfAngle));
+
+	UFirstPersonInteractableComponent* BestCandidate = nullptr;
+	float BestDot = MinDot;
+
+	const auto VisitCell = [&](const TArray<UFirstPersonInteractableComponent*>& Cell)
+	{
+		for (UFirstPersonInteractableComponent* Interactable : Cell)
+		{
+			if (!Interactable->IsInteractionEnabled() || Interactable->GetOwner() == IgnoreActor)
+				continue;
+
+			const FVector ToInteractable = Interactable->GetComponentLocation() - ViewLocation;
+			const float DistanceSquared = ToInteractable.SizeSquared();
+			if (DistanceSquared > MaxDistanceSquared || DistanceSquared < KINDA_SMALL_NUMBER)
+				continue;
+
+			// Prefer whatever is closest to the center of the view
+			const float Dot = FVector::DotProduct(ToInteractable * FMath::InvSqrt(DistanceSquared), ViewDirection);
+			if (Dot >= BestDot)
+			{
+				BestDot = Dot;
+				BestCandidate = Interactable;
+			}
+		}
+	};
+
+	// Walk whichever is smaller, the cells covered by the query or the cells that actually hold interactables
+	const int64 NumQueryCells = static_cast<int64>(MaxCell.X - MinCell.X + 1) * (MaxCell.Y - MinCell.Y + 1) * (MaxCell.Z - MinCell.Z + 1);
+	if (NumQueryCells > Cells.Num())
+	{
+		for (const auto& Cell : Cells)
+		{
+			const FIntVector& Key = Cell.Key;
+			if (Key.X >= MinCell.X && Key.X <= MaxCell.X && Key.Y >= MinCell.Y && Key.Y <= MaxCell.Y && Key.Z >= MinCell.Z && Key.Z <= MaxCell.Z)
+				VisitCell(Cell.Value);
+		}
+	}
+	else
+	{
+		for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+		{
+			for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+			{
+				for (int32 Z = MinCell.Z; Z <= MaxCell.Z; Z++)
+				{
+					if (const TArray<UFirstPersonInteractableComponent*>* Cell = Cells.Find(FIntVector(X, Y, Z)))
+						VisitCell(*Cell);
+				}
+			}
+		}
+	}
+
+	return BestCandidate;
+}
+
+FIntVector UFirstPersonInteractionSubsystem::GetCell(const FVector& Location) const
+{
+	return FIntVector(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize), FMath::FloorToInt(Location.Z / CellSize));
+}
@@ -0,0 +1,33 @@
+// Copyright Ali El Saleh, 2020
+
+#include "FirstPersonLagCompensationSubsystem.h"
+#include "FPCharacter.h"
+
+#include "Components/CapsuleComponent.h"
+
+void UFirstPersonLagCompensationSubsystem::Register(AFPCharacter* Character)
+{
+	Characters.AddUnique(Character);
+}
+
+void UFirstPersonLagCompensationSubsystem::Unregister(AFPCharacter* Character)
+{
+	Characters.RemoveSwap(Character);
+}
+
+void UFirstPersonLagCompensationSubsystem::RewindAll(const float Timestamp, TArray<FFirstPersonRewoundCapsule>& OutCapsules) const
+{
+	OutCapsules.Reset(Characters.Num());
+
+	for (AFPCharacter* Character : Characters)
+	{
+		if (Character->GetCapsuleHistory().Num() == 0)
+			continue;
+
+		FFirstPersonRewoundCapsule& Capsule = OutCapsules.AddDefaulted_GetRef();
+		Capsule.Character = Character;
+		Capsule.Radius = Character->GetCapsuleComponent()->GetScaledCapsuleRadius();
+
+		Capsule.bValid = Character->GetCapsuleHistory().Rewind(Timestamp, Capsule.Sample);
+	}
+}
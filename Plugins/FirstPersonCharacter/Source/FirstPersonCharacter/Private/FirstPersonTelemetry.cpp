@@ -0,0 +1,217 @@
+// Copyright Ali El Saleh, 2020
+
+#include "FirstPersonTelemetry.h"
+
+#include "GenericPlatform/GenericPlatformFile.h"
+
+#include "HAL/Event.h"
+#include "HAL/PlatformFilemanager.h"
+#include "HAL/RunnableThread.h"
+
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+FFirstPersonTelemetryWriter* FFirstPersonTelemetryWriter::Instance = nullptr;
+
+FFirstPersonTelemetryStream::FFirstPersonTelemetryStream(const uint32 Capacity)
+	: Ring(Capacity)
+{
+}
+
+FFirstPersonTelemetryStream::~FFirstPersonTelemetryStream()
+{
+	if (FileHandle)
+	{
+		FileHandle->Flush();
+		delete FileHandle;
+	}
+
+	if (DroppedEvents > 0)
+		UE_LOG(LogTemp, Warning, TEXT("Telemetry dropped %u events, consider increasing the buffer capacity"), DroppedEvents)
+}
+
+bool FFirstPersonTelemetryStream::Open(const FString& Filename)
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(Filename));
+
+	FileHandle = PlatformFile.OpenWrite(*Filename);
+	if (!FileHandle)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Failed to open telemetry file %s"), *Filename)
+		return false;
+	}
+
+	const FFirstPersonTelemetryHeader Header;
+	FileHandle->Write(reinterpret_cast<const uint8*>(&Header), sizeof(Header));
+	return true;
+}
+
+void FFirstPersonTelemetryStream::Drain(TArray<FFirstPersonTelemetryEvent>& Scratch)
+{
+	Scratch.Reset();
+
+	if (Ring.DequeueAll(Scratch) > 0)
+		FileHandle->Write(reinterpret_cast<const uint8*>(Scratch.GetData()), Scratch.Num() * sizeof(FFirstPersonTelemetryEvent));
+}
+
+FFirstPersonTelemetryWriter::FFirstPersonTelemetryWriter()
+{
+	WakeEvent = FPlatformProcess::GetSynchEventFromPool();
+}
+
+FFirstPersonTelemetryWriter::~FFirstPersonTelemetryWriter()
+{
+	// Wakes the thread and waits for its final drain
+	if (Thread)
+	{
+		Thread->Kill(true);
+		delete Thread;
+	}
+
+	FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+}
+
+bool FFirstPersonTelemetryWriter::Register(const FFirstPersonTelemetryStreamRef& Stream)
+{
+	if (!Instance)
+	{
+		if (!FPlatformProcess::SupportsMultithreading())
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Telemetry requires multithreading support, no events will be recorded"))
+			return false;
+		}
+
+		Instance = new FFirstPersonTelemetryWriter();
+		Instance->Thread = FRunnableThread::Create(Instance, TEXT("FirstPersonTelemetry"), 0, TPri_BelowNormal);
+		if (!Instance->Thread)
+		{
+			delete Instance;
+			Instance = nullptr;
+			return false;
+		}
+	}
+
+	FScopeLock Lock(&Instance->StreamsLock);
+	Instance->Streams.Add(Stream);
+	return true;
+}
+
+void FFirstPersonTelemetryWriter::Unregister(const FFirstPersonTelemetryStreamRef& Stream)
+{
+	if (!Instance)
+		return;
+
+	FScopeLock Lock(&Instance->StreamsLock);
+	if (Instance->Streams.RemoveSwap(Stream) > 0)
+		Instance->ClosingStreams.Add(Stream);
+}
+
+void FFirstPersonTelemetryWriter::Shutdown()
+{
+	delete Instance;
+	Instance = nullptr;
+}
+
+uint32 FFirstPersonTelemetryWriter::Run()
+{
+	while (!bStopRequested.load(std::memory_order_relaxed))
+	{
+		DrainAll();
+
+		// Stop() triggers the event, so shutting down never waits out the flush interval
+		WakeEvent->Wait(10);
+	}
+
+	// Pick up anything recorded between the last drain and the stop request
+	DrainAll();
+	return 0;
+}
+
+void FFirstPersonTelemetryWriter::Stop()
+{
+	bStopRequested.store(true, std::memory_order_relaxed);
+	WakeEvent->Trigger();
+}
+
+void FFirstPersonTelemetryWriter::DrainAll()
+{
+	// Closing streams get one last drain, then their final reference is released here so file IO stays on this thread
+	{
+		FScopeLock Lock(&StreamsLock);
+		DrainingStreams.Reset();
+		DrainingStreams.Append(Streams);
+		DrainingStreams.Append(ClosingStreams);
+		ClosingStreams.Reset();
+	}
+
+	for (const FFirstPersonTelemetryStreamRef& Stream : DrainingStreams)
+		Stream->Drain(PendingEvents);
+
+	DrainingStreams.Reset();
+}
+
+bool FFirstPersonTelemetryWriter::ConvertToCsv(const FString& InFilename, const FString& OutFilename)
+{
+	TArray<uint8> Data;
+	if (!FFileHelper::LoadFileToArray(Data, *InFilename))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Failed to read telemetry file %s"), *InFilename)
+		return false;
+	}
+
+	FFirstPersonTelemetryHeader Header;
+	if (Data.Num() < static_cast<int32>(sizeof(Header)))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s is too small to be a telemetry file"), *InFilename)
+		return false;
+	}
+
+	FMemory::Memcpy(&Header, Data.GetData(), sizeof(Header));
+	if (Header.Magic != FFirstPersonTelemetryHeader::ExpectedMagic || Header.Version != FFirstPersonTelemetryHeader::CurrentVersion || Header.EventSize != sizeof(FFirstPersonTelemetryEvent))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s is not a version %u telemetry file"), *InFilename, FFirstPersonTelemetryHeader::CurrentVersion)
+		return false;
+	}
+
+	const auto GetTypeName = [](const EFirstPersonTelemetryEventType Type)
+	{
+		switch (Type)
+		{
+			case EFirstPersonTelemetryEventType::Footstep:		return TEXT("Footstep");
+			case EFirstPersonTelemetryEventType::Landed:		return TEXT("Landed");
+			case EFirstPersonTelemetryEventType::StanceChanged:	return TEXT("StanceChanged");
+			case EFirstPersonTelemetryEventType::GaitChanged:	return TEXT("GaitChanged");
+			default:											return TEXT("Unknown");
+		}
+	};
+
+	const int32 NumEvents = static_cast<int32>((Data.Num() - sizeof(Header)) / sizeof(FFirstPersonTelemetryEvent));
+
+	FString Csv = TEXT("Timestamp,Type,Surface,Stance,Gait,X,Y,Z,Value\n");
+	Csv.Reserve(NumEvents * 64);
+
+	for (int32 i = 0; i < NumEvents; i++)
+	{
+		FFirstPersonTelemetryEvent Event;
+		FMemory::Memcpy(&Event, Data.GetData() + sizeof(Header) + i * sizeof(FFirstPersonTelemetryEvent), sizeof(Event));
+
+		Csv += FString::Printf(TEXT("%.4f,%s,%u,%s,%s,%.2f,%.2f,%.2f,%.2f\n"),
+			Event.Timestamp,
+			GetTypeName(Event.Type),
+			Event.Surface,
+			Event.Stance == EFirstPersonStance::Crouching ? TEXT("Crouching") : TEXT("Standing"),
+			Event.Gait == EFirstPersonGait::Running ? TEXT("Running") : TEXT("Walking"),
+			Event.Location.X, Event.Location.Y, Event.Location.Z,
+			Event.Value);
+	}
+
+	if (!FFileHelper::SaveStringToFile(Csv, *OutFilename))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Failed to write %s"), *OutFilename)
+		return false;
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("Converted %d telemetry events to %s"), NumEvents, *OutFilename)
+	return true;
+}
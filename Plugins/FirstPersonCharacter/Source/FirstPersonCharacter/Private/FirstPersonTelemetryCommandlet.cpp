@@ -0,0 +1,29 @@
+// Copyright Ali El Saleh, 2020
+
+#include "FirstPersonTelemetryCommandlet.h"
+#include "FirstPersonTelemetry.h"
+
+#include "Misc/Paths.h"
+
+UFirstPersonTelemetryCommandlet::UFirstPersonTelemetryCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UFirstPersonTelemetryCommandlet::Main(const FString& Params)
+{
+	FString InFilename;
+	if (!FParse::Value(*Params, TEXT("Input="), InFilename))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Usage: -run=FirstPersonTelemetry -Input=<File.fptl> [-Output=<File.csv>]"))
+		return 1;
+	}
+
+	FString OutFilename;
+	if (!FParse::Value(*Params, TEXT("Output="), OutFilename))
+		OutFilename = FPaths::ChangeExtension(InFilename, TEXT("csv"));
+
+	return FFirstPersonTelemetryWriter::ConvertToCsv(InFilename, OutFilename) ? 0 : 1;
+}
@@ -7,8 +7,13 @@
 #include "GameFramework/CharacterMovementComponent.h"
 #include "GameFramework/PlayerInput.h"
 
+#include "FirstPersonCapsuleHistory.h"
+#include "FirstPersonTelemetry.h"
+
 #include "FPCharacter.generated.h"
 
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FFirstPersonFocusChangedSignature, class UFirstPersonInteractableComponent*, NewFocus, class UFirstPersonInteractableComponent*, OldFocus);
+
 USTRUCT()
 struct FCameraShakes
 {
@@ -80,6 +85,63 @@ struct FFirstPersonCameraSettings
         float MaxPitch = 90.0f;
 };
 
+USTRUCT()
+struct FFirstPersonSimulationSettings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditInstanceOnly, Category = "Simulation", meta = (ToolTip = "Enable/Disable stepping footsteps, crouching and camera shakes at a fixed rate instead of every frame? The camera is interpolated between steps and look sensitivity is scaled as if running at 60 FPS, regardless of frame rate or step rate"))
+		bool bUseFixedTimestep = false;
+
+	UPROPERTY(EditInstanceOnly, Category = "Simulation", meta = (EditCondition = "bUseFixedTimestep", ClampMin=1.0f, ClampMax=1000.0f, ToolTip = "How many locomotion steps to simulate per second"))
+		float FixedTimestepRate = 60.0f;
+
+	UPROPERTY(EditInstanceOnly, Category = "Simulation", meta = (EditCondition = "bUseFixedTimestep", ClampMin=1, ClampMax=32, ToolTip = "The most steps simulated in a single frame. Time beyond that is dropped so a long hitch cannot snowball"))
+		int32 MaxStepsPerFrame = 4;
+};
+
+USTRUCT()
+struct FFirstPersonTelemetrySettings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditInstanceOnly, Category = "Telemetry", meta = (ToolTip = "Enable/Disable recording of locomotion events (footsteps, landings, stance and gait changes) to Saved/Telemetry?"))
+		bool bEnableTelemetry = false;
+
+	UPROPERTY(EditInstanceOnly, Category = "Telemetry", meta = (EditCondition = "bEnableTelemetry", ClampMin=16, ClampMax=65536, ToolTip = "How many events can be queued before the background writer has to catch up. Rounded up to a power of two"))
+		int32 BufferCapacity = 1024;
+};
+
+USTRUCT()
+struct FFirstPersonLagCompensationSettings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditInstanceOnly, Category = "Lag Compensation", meta = (ToolTip = "Enable/Disable recording of the capsule state every server frame so hits can be validated against where this character was in the past?"))
+		bool bRecordCapsuleHistory = true;
+
+	UPROPERTY(EditInstanceOnly, Category = "Lag Compensation", meta = (EditCondition = "bRecordCapsuleHistory", ClampMin=2, ClampMax=4096, ToolTip = "How many server frames of capsule history to keep. Rounded up to a power of two"))
+		int32 HistorySize = 128;
+};
+
+USTRUCT()
+struct FFirstPersonInteractionSettings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditInstanceOnly, Category = "Interaction", meta = (ToolTip = "Enable/Disable focusing interactables in front of the camera?"))
+		bool bEnableInteraction = true;
+
+	UPROPERTY(EditInstanceOnly, Category = "Interaction", meta = (EditCondition = "bEnableInteraction", ClampMin=1.0f, ClampMax=1000.0f, ToolTip = "How far away can an interactable be focused? Kept within a couple of interaction grid cells so focusing stays cheap"))
+		float InteractionDistance = 250.0f;
+
+	UPROPERTY(EditInstanceOnly, Category = "Interaction", meta = (EditCondition = "bEnableInteraction", ClampMin=0.0f, ClampMax=90.0f, ToolTip = "How far from the center of the view can an interactable be focused, in degrees?"))
+		float FocusAngle = 15.0f;
+
+	UPROPERTY(EditInstanceOnly, Category = "Interaction", meta = (EditCondition = "bEnableInteraction", ClampMin=0.0f, ClampMax=5.0f, ToolTip = "How often to re-check that the interactable we are looking at is still (or has become) visible, in seconds"))
+		float FocusRecheckInterval = 0.1f;
+};
+
 UCLASS()
 class FIRSTPERSONCHARACTER_API AFPCharacter : public ACharacter
 {
@@ -88,15 +150,29 @@ class FIRSTPERSONCHARACTER_API AFPCharacter : public ACharacter
 public:
 	AFPCharacter();
 
+	const FFirstPersonCapsuleHistory& GetCapsuleHistory() const { return CapsuleHistory; }
+
+	UFUNCTION(BlueprintPure, Category = "Interaction")
+		class UFirstPersonInteractableComponent* GetFocusedInteractable() const { return FocusedInteractable.Get(); }
+
+	UPROPERTY(BlueprintAssignable, Category = "Interaction")
+		FFirstPersonFocusChangedSignature OnFocusChanged;
+
+	// Drops Interactable as the focus or focus candidate, called when it leaves play
+	void ReleaseFocus(class UFirstPersonInteractableComponent* Interactable);
+
 protected:
 	void BeginPlay() override;
+	void EndPlay(EEndPlayReason::Type EndPlayReason) override;
 	void Tick(float DeltaTime) override;
 	void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
 	void Jump() override;
 	void Landed(const FHitResult& Hit) override;
 	void PossessedBy(AController* NewController) override;
+	void PawnClientRestart() override;
 	void StartCrouch();
 	void StopCrouching();
+	void SetCrouching(bool bNewCrouching);
 	void SetupInputBindings();
 	void ResetInputBindings();
 	void ResetToDefaultInputBindings();
@@ -112,9 +188,24 @@ protected:
 	void PlayFootstepSound();
 	USoundBase* GetFootstepSound(TWeakObjectPtr<UPhysicalMaterial>* Surface);
 
+	void StepLocomotion(float DeltaTime);
+	void UpdateFootsteps();
 	void UpdateCrouch(float DeltaTime);
 	bool IsBlockedInCrouchStance();
 	void UpdateCameraShake();
+	float GetLookInputDeltaTime() const;
+	void RecordCapsuleSample();
+	void UpdateInteractionFocus();
+	void SetFocusedInteractable(class UFirstPersonInteractableComponent* NewFocus);
+
+	void StartTelemetry();
+	void RecordTelemetryEvent(EFirstPersonTelemetryEventType Type, const FVector& Location, uint8 Surface = 0, float Value = 0.0f) const;
+
+	UFUNCTION(Server, Reliable)
+		void ServerSetCrouching(bool bNewCrouching);
+
+	UFUNCTION(Server, Reliable)
+		void ServerInteract(class UFirstPersonInteractableComponent* Interactable);
 
 	UFUNCTION()
 		virtual void Interact();
@@ -144,6 +235,18 @@ protected:
 	UPROPERTY(EditAnywhere, Category = "First Person Settings", meta = (ToolTip = "Add one of your custom camera shakes to the corresponding slot"))
 		FCameraShakes CameraShakes;
 
+	UPROPERTY(EditAnywhere, Category = "First Person Settings", meta = (ToolTip = "Decouple the locomotion effects from the render frame rate"))
+		FFirstPersonSimulationSettings Simulation;
+
+	UPROPERTY(EditAnywhere, Category = "First Person Settings", meta = (ToolTip = "Record locomotion events to a binary log for post-session analysis"))
+		FFirstPersonTelemetrySettings Telemetry;
+
+	UPROPERTY(EditAnywhere, Category = "First Person Settings", meta = (ToolTip = "Server-side capsule history used to validate hits against past stances"))
+		FFirstPersonLagCompensationSettings LagCompensation;
+
+	UPROPERTY(EditAnywhere, Category = "First Person Settings", meta = (ToolTip = "Adjust how interactables are focused"))
+		FFirstPersonInteractionSettings Interaction;
+
 	class UInputSettings* Input{};
 
 private:
@@ -160,10 +263,24 @@ private:
 	float OriginalCapsuleHalfHeight{};
 	FVector OriginalCameraLocation; // Relative
 
+	// Simulation variables
+	FVector SimulatedCameraLocation; // Relative, as of the latest step
+	FVector PreviousCameraLocation; // Relative, as of the step before
+	float SimulationAccumulator = 0.0f;
+
 	bool bCanUnCrouch{};
 	bool bIsCrouching{};
 	bool bIsRunning{};
 
 	TArray<FInputActionKeyMapping> ActionMappings;
 	TArray<FInputAxisKeyMapping> AxisMappings;
+
+	TSharedPtr<FFirstPersonTelemetryStream, ESPMode::ThreadSafe> TelemetryStream;
+
+	FFirstPersonCapsuleHistory CapsuleHistory;
+
+	// Interaction variables
+	TWeakObjectPtr<class UFirstPersonInteractableComponent> FocusCandidate;
+	TWeakObjectPtr<class UFirstPersonInteractableComponent> FocusedInteractable;
+	float LastFocusTraceTime = 0.0f;
 };
@@ -0,0 +1,55 @@
+// Copyright Ali El Saleh, 2020
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "FirstPersonTypes.h"
+
+/**
+ * The state of a character's capsule at one point in time
+ */
+struct FFirstPersonCapsuleSample
+{
+	float Timestamp = 0.0f; // World time in seconds
+	FVector Location = FVector::ZeroVector; // Capsule center
+	FQuat Rotation = FQuat::Identity;
+	float HalfHeight = 0.0f; // Scaled
+	EFirstPersonStance Stance = EFirstPersonStance::Standing;
+};
+
+/**
+ * Fixed-size ring of capsule samples, ordered by time. Never allocates after Init
+ */
+class FIRSTPERSONCHARACTER_API FFirstPersonCapsuleHistory
+{
+public:
+	// Allocates room for Capacity samples (rounded up to a power of two) and clears the history
+	void Init(int32 Capacity);
+	void Reset();
+
+	// Appends a sample. A sample that is not newer than the latest one replaces it
+	void Record(const FFirstPersonCapsuleSample& Sample);
+
+	// Interpolates the capsule state at Timestamp. Timestamps newer than the history clamp to the latest sample.
+	// Returns false if there are no samples or Timestamp predates the history, OutSample is still clamped to the oldest sample in the latter case
+	bool Rewind(float Timestamp, FFirstPersonCapsuleSample& OutSample) const;
+
+	int32 Num() const { return Count; }
+	bool IsInitialized() const { return Samples.Num() > 0; }
+
+	float GetOldestTimestamp() const { return Count > 0 ? GetSample(0).Timestamp : 0.0f; }
+	float GetNewestTimestamp() const { return Count > 0 ? GetSample(Count - 1).Timestamp : 0.0f; }
+
+private:
+	// Index 0 is the oldest sample
+	FORCEINLINE const FFirstPersonCapsuleSample& GetSample(const int32 Index) const
+	{
+		return Samples[(Head - Count + Index) & Mask];
+	}
+
+	TArray<FFirstPersonCapsuleSample> Samples;
+	int32 Mask = 0;
+	int32 Head = 0; // Next slot to write
+	int32 Count = 0;
+};
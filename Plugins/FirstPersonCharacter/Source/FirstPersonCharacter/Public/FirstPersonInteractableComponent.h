@@ -0,0 +1,56 @@
+// Copyright Ali El Saleh, 2020
+
+#pragma once
+
+#include "Components/SceneComponent.h"
+#include "FirstPersonInteractableComponent.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FFirstPersonInteractionSignature, class AFPCharacter*, Character);
+
+/**
+ * Makes its owner focusable and interactable by AFPCharacter. The component's location is what the character looks at
+ */
+UCLASS(ClassGroup = "First Person", meta = (BlueprintSpawnableComponent))
+class FIRSTPERSONCHARACTER_API UFirstPersonInteractableComponent : public USceneComponent
+{
+	GENERATED_BODY()
+
+	friend class UFirstPersonInteractionSubsystem;
+	friend class AFPCharacter;
+
+public:
+	UFUNCTION(BlueprintPure, Category = "Interaction")
+		bool IsInteractionEnabled() const { return bInteractionEnabled; }
+
+	UFUNCTION(BlueprintCallable, Category = "Interaction")
+		void SetInteractionEnabled(bool bEnabled) { bInteractionEnabled = bEnabled; }
+
+	void Interact(class AFPCharacter* Character);
+
+	// Broadcast on the server (or standalone game) once it has validated the interaction. Replicate any results from there
+	UPROPERTY(BlueprintAssignable, Category = "Interaction")
+		FFirstPersonInteractionSignature OnInteract;
+
+	// Focus events are local to the player doing the looking, use them for prompts and highlights
+	UPROPERTY(BlueprintAssignable, Category = "Interaction")
+		FFirstPersonInteractionSignature OnFocusBegin;
+
+	UPROPERTY(BlueprintAssignable, Category = "Interaction")
+		FFirstPersonInteractionSignature OnFocusEnd;
+
+protected:
+	void BeginPlay() override;
+	void EndPlay(EEndPlayReason::Type EndPlayReason) override;
+	void OnUpdateTransform(EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport) override;
+
+	UPROPERTY(EditAnywhere, Category = "Interaction", meta = (ToolTip = "Can characters currently focus and interact with this?"))
+		bool bInteractionEnabled = true;
+
+private:
+	// Grid cell this component is stored in, maintained by the interaction subsystem
+	FIntVector GridCell;
+	bool bIsInGrid = false;
+
+	// Characters currently focusing this, released when it leaves play so their focus events still fire
+	TArray<TWeakObjectPtr<class AFPCharacter>> FocusingCharacters;
+};
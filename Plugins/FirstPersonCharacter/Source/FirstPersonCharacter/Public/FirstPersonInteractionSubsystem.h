@@ -0,0 +1,36 @@
+// Copyright Ali El Saleh, 2020
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+#include "FirstPersonInteractionSubsystem.generated.h"
+
+/**
+ * Stores every interactable in the world in a spatial hash grid, so finding what a character is looking at
+ * only visits the few cells around it regardless of how many interactables the level has
+ */
+UCLASS(Config = Game)
+class FIRSTPERSONCHARACTER_API UFirstPersonInteractionSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	void Add(class UFirstPersonInteractableComponent* Interactable);
+	void Remove(class UFirstPersonInteractableComponent* Interactable);
+	void Update(class UFirstPersonInteractableComponent* Interactable);
+
+	// Returns the enabled interactable within MaxDistance closest to the view direction, inside a cone of HalfAngle degrees.
+	// This is a grid query only, visibility is up to the caller
+	class UFirstPersonInteractableComponent* FindFocusCandidate(const FVector& ViewLocation, const FVector& ViewDirection, float MaxDistance, float HalfAngle, const AActor* IgnoreActor = nullptr) const;
+
+private:
+	FIntVector GetCell(const FVector& Location) const;
+
+	// Size of a grid cell in world units. Roughly match the interaction distance so a query only visits a handful of cells
+	UPROPERTY(Config)
+		float CellSize = 500.0f;
+
+	TMap<FIntVector, TArray<class UFirstPersonInteractableComponent*>> Cells;
+};
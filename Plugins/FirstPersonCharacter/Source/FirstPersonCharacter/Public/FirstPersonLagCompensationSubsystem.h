@@ -0,0 +1,42 @@
+// Copyright Ali El Saleh, 2020
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+
+#include "FirstPersonCapsuleHistory.h"
+
+#include "FirstPersonLagCompensationSubsystem.generated.h"
+
+/**
+ * A character's capsule as it was at a rewound timestamp
+ */
+struct FFirstPersonRewoundCapsule
+{
+	class AFPCharacter* Character = nullptr;
+	FFirstPersonCapsuleSample Sample;
+	float Radius = 0.0f; // Scaled
+
+	// False when the timestamp predates this character's history. Sample is then clamped to the oldest state and should not be trusted for hit validation
+	bool bValid = false;
+};
+
+/**
+ * Tracks every character recording a capsule history on the server so hits can be validated against past capsule states
+ */
+UCLASS()
+class FIRSTPERSONCHARACTER_API UFirstPersonLagCompensationSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	void Register(class AFPCharacter* Character);
+	void Unregister(class AFPCharacter* Character);
+
+	// Rewinds every registered character with at least one sample to Timestamp. OutCapsules is reset but keeps its allocation, so reuse it between shots
+	void RewindAll(float Timestamp, TArray<FFirstPersonRewoundCapsule>& OutCapsules) const;
+
+private:
+	UPROPERTY()
+		TArray<class AFPCharacter*> Characters;
+};
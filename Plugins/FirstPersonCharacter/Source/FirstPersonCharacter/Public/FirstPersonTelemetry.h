@@ -0,0 +1,185 @@
+// Copyright Ali El Saleh, 2020
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "HAL/Runnable.h"
+
+#include "FirstPersonTypes.h"
+
+#include <atomic>
+
+enum class EFirstPersonTelemetryEventType : uint8
+{
+	Footstep,
+	Landed,
+	StanceChanged,
+	GaitChanged
+};
+
+/**
+ * A single locomotion event, written to disk as-is (little-endian, 24 bytes)
+ */
+struct FFirstPersonTelemetryEvent
+{
+	float Timestamp = 0.0f; // World time in seconds
+	EFirstPersonTelemetryEventType Type = EFirstPersonTelemetryEventType::Footstep;
+	uint8 Surface = 0; // EPhysicalSurface
+	EFirstPersonStance Stance = EFirstPersonStance::Standing;
+	EFirstPersonGait Gait = EFirstPersonGait::Walking;
+	FVector Location = FVector::ZeroVector;
+	float Value = 0.0f; // Event specific. Stride for footsteps, impact speed for landings
+};
+
+static_assert(sizeof(FFirstPersonTelemetryEvent) == 24, "Telemetry event layout is part of the file format, bump the version when changing it");
+
+/**
+ * Prepended once to every telemetry log
+ */
+struct FFirstPersonTelemetryHeader
+{
+	static constexpr uint32 ExpectedMagic = 0x4C545046; // "FPTL"
+	static constexpr uint16 CurrentVersion = 1;
+
+	uint32 Magic = ExpectedMagic;
+	uint16 Version = CurrentVersion;
+	uint16 EventSize = sizeof(FFirstPersonTelemetryEvent);
+};
+
+/**
+ * Fixed capacity, lock-free ring buffer for exactly one producer thread and one consumer thread
+ */
+template<typename ElementType>
+class TFirstPersonSpscRing
+{
+public:
+	explicit TFirstPersonSpscRing(const uint32 InCapacity)
+	{
+		const uint32 Capacity = FMath::RoundUpToPowerOfTwo(FMath::Max<uint32>(InCapacity, 2));
+		Buffer.SetNumUninitialized(Capacity);
+		Mask = Capacity - 1;
+	}
+
+	// Producer only. Returns false when the ring is full
+	FORCEINLINE bool Enqueue(const ElementType& Item)
+	{
+		const uint32 CurrentHead = Head.load(std::memory_order_relaxed);
+
+		// Only touch the consumer's cache line when our cached view says we are full
+		if (CurrentHead - CachedTail > Mask)
+		{
+			CachedTail = Tail.load(std::memory_order_acquire);
+			if (CurrentHead - CachedTail > Mask)
+				return false;
+		}
+
+		Buffer[CurrentHead & Mask] = Item;
+		Head.store(CurrentHead + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer only. Appends every available element to OutItems and returns how many were added
+	int32 DequeueAll(TArray<ElementType>& OutItems)
+	{
+		const uint32 CurrentTail = Tail.load(std::memory_order_relaxed);
+		const uint32 CurrentHead = Head.load(std::memory_order_acquire);
+		const int32 Count = static_cast<int32>(CurrentHead - CurrentTail);
+
+		for (uint32 i = CurrentTail; i != CurrentHead; i++)
+			OutItems.Add(Buffer[i & Mask]);
+
+		Tail.store(CurrentHead, std::memory_order_release);
+		return Count;
+	}
+
+private:
+	TArray<ElementType> Buffer;
+	uint32 Mask = 0;
+
+	// Producer and consumer indices are padded onto separate cache lines to avoid false sharing.
+	// Padding rather than alignas, the ring is heap allocated and aligned operator new is not available
+	std::atomic<uint32> Head{0};
+	uint32 CachedTail = 0;
+	uint8 ProducerPadding[PLATFORM_CACHE_LINE_SIZE - sizeof(std::atomic<uint32>) - sizeof(uint32)];
+
+	std::atomic<uint32> Tail{0};
+	uint8 ConsumerPadding[PLATFORM_CACHE_LINE_SIZE - sizeof(std::atomic<uint32>)];
+};
+
+/**
+ * One character's telemetry log. The game thread records into the ring, the shared writer thread drains it to disk
+ */
+class FIRSTPERSONCHARACTER_API FFirstPersonTelemetryStream
+{
+public:
+	explicit FFirstPersonTelemetryStream(uint32 Capacity);
+	~FFirstPersonTelemetryStream();
+
+	// Creates the log file and writes its header
+	bool Open(const FString& Filename);
+
+	// Game thread only. Drops the event if the writer thread has fallen behind
+	FORCEINLINE void Record(const FFirstPersonTelemetryEvent& Event)
+	{
+		if (!Ring.Enqueue(Event))
+			DroppedEvents++;
+	}
+
+	uint32 GetDroppedEvents() const { return DroppedEvents; }
+
+private:
+	friend class FFirstPersonTelemetryWriter;
+
+	// Writer thread only
+	void Drain(TArray<FFirstPersonTelemetryEvent>& Scratch);
+
+	TFirstPersonSpscRing<FFirstPersonTelemetryEvent> Ring;
+	class IFileHandle* FileHandle = nullptr;
+	uint32 DroppedEvents = 0;
+};
+
+using FFirstPersonTelemetryStreamRef = TSharedRef<FFirstPersonTelemetryStream, ESPMode::ThreadSafe>;
+
+/**
+ * The single background thread that drains every registered telemetry stream. Started on first use, stopped when the module shuts down
+ */
+class FIRSTPERSONCHARACTER_API FFirstPersonTelemetryWriter : public FRunnable
+{
+public:
+	// Starts draining Stream, starting the writer thread if needed. Returns false if the platform cannot run it
+	static bool Register(const FFirstPersonTelemetryStreamRef& Stream);
+
+	// Stops draining Stream after one final drain on the writer thread. Never blocks the caller on file IO
+	static void Unregister(const FFirstPersonTelemetryStreamRef& Stream);
+
+	// Flushes every stream and joins the writer thread
+	static void Shutdown();
+
+	// Converts a telemetry log to a comma-separated text file
+	static bool ConvertToCsv(const FString& InFilename, const FString& OutFilename);
+
+protected:
+	uint32 Run() override;
+	void Stop() override;
+
+private:
+	FFirstPersonTelemetryWriter();
+	~FFirstPersonTelemetryWriter();
+
+	void DrainAll();
+
+	static FFirstPersonTelemetryWriter* Instance;
+
+	FCriticalSection StreamsLock;
+	TArray<FFirstPersonTelemetryStreamRef> Streams;
+	TArray<FFirstPersonTelemetryStreamRef> ClosingStreams;
+
+	// Writer thread only
+	TArray<FFirstPersonTelemetryStreamRef> DrainingStreams;
+	TArray<FFirstPersonTelemetryEvent> PendingEvents;
+
+	class FEvent* WakeEvent = nullptr;
+	class FRunnableThread* Thread = nullptr;
+	std::atomic<bool> bStopRequested{false};
+};
@@ -0,0 +1,22 @@
+// Copyright Ali El Saleh, 2020
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "FirstPersonTelemetryCommandlet.generated.h"
+
+/**
+ * Converts a binary telemetry log recorded by AFPCharacter into CSV
+ *
+ * Usage: -run=FirstPersonTelemetry -Input=<File.fptl> [-Output=<File.csv>]
+ */
+UCLASS()
+class FIRSTPERSONCHARACTER_API UFirstPersonTelemetryCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UFirstPersonTelemetryCommandlet();
+
+	int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,17 @@
+// Copyright Ali El Saleh, 2020
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+enum class EFirstPersonStance : uint8
+{
+	Standing,
+	Crouching
+};
+
+enum class EFirstPersonGait : uint8
+{
+	Walking,
+	Running
+};